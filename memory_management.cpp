@@ -132,6 +132,202 @@ int memory_management_realloc() {
     free(ptr);
 }
 
+/*
+GrowableBuffer<T>:
+memory_management_realloc above grows a buffer once, by hand. GrowableBuffer packages the same
+idea for any trivially copyable T (ints, doubles, POD structs):
+🔹 Geometric growth: capacity grows by 1.5x (at least to what is needed), so n push_backs
+   cost O(n) in total.
+🔹 Grow in place: realloc can often extend the block where it is, instead of allocating a
+   new one and copying like std::vector must. On Linux, buffers of 1 MiB and more live in
+   their own mapping and grow with mremap, which moves pages by editing page tables and never
+   copies the data, however large.
+🔹 shrink_to_fit() gives unused capacity back the same way.
+🔹 Because T is trivially copyable, moving the bytes is a valid way to move the objects.
+   (C++ has no "trivially relocatable" trait yet, so trivially copyable is the safe stand-in.)
+Failures throw std::bad_alloc and leave the buffer unchanged.
+*/
+#include <new>
+#include <type_traits>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+template <typename T>
+class GrowableBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "GrowableBuffer moves elements with realloc/mremap");
+
+public:
+    GrowableBuffer() = default;
+    explicit GrowableBuffer(size_t n) { resize(n); }
+
+    ~GrowableBuffer() { release(data_, capacity_ * sizeof(T), mapped); }
+
+    GrowableBuffer(const GrowableBuffer&) = delete;
+    GrowableBuffer& operator=(const GrowableBuffer&) = delete;
+
+    GrowableBuffer(GrowableBuffer&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)),
+          capacity_(std::exchange(other.capacity_, 0)), mapped(std::exchange(other.mapped, false)) {}
+
+    GrowableBuffer& operator=(GrowableBuffer&& other) noexcept {
+        if (this != &other) {
+            release(data_, capacity_ * sizeof(T), mapped);
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            capacity_ = std::exchange(other.capacity_, 0);
+            mapped = std::exchange(other.mapped, false);
+        }
+        return *this;
+    }
+
+    // value may refer into this buffer (buf.push_back(buf[0])), so it is copied before
+    // growing can move the storage away
+    void push_back(const T& value) {
+        if (size_ == capacity_) {
+            T copy = value;
+            grow(size_ + 1);
+            data_[size_++] = copy;
+            return;
+        }
+        data_[size_++] = value;
+    }
+
+    // values may point into this buffer; such a range is found again after growing
+    void append(const T* values, size_t n) {
+        if (n > capacity_ - size_) {
+            auto address = reinterpret_cast<std::uintptr_t>(values);
+            auto first = reinterpret_cast<std::uintptr_t>(data_);
+            bool inside = data_ && address >= first && address < first + size_ * sizeof(T);
+            size_t offset = inside ? static_cast<size_t>(values - data_) : 0;
+            grow(size_ + n);
+            if (inside) values = data_ + offset;
+        }
+        if (n) std::memcpy(data_ + size_, values, n * sizeof(T));
+        size_ += n;
+    }
+
+    // New elements are zero-initialized
+    void resize(size_t n) {
+        if (n > capacity_) grow(n);
+        if (n > size_) std::memset(static_cast<void*>(data_ + size_), 0, (n - size_) * sizeof(T));
+        size_ = n;
+    }
+
+    void reserve(size_t n) {
+        if (n > capacity_) reallocate(n);
+    }
+
+    void shrink_to_fit() {
+        if (size_ < capacity_) reallocate(size_);
+    }
+
+    void clear() { size_ = 0; }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    T& operator[](size_t index) { return data_[index]; }
+    const T& operator[](size_t index) const { return data_[index]; }
+    T* begin() { return data_; }
+    T* end() { return data_ + size_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+
+private:
+    static constexpr size_t map_threshold = size_t(1) << 20;   // bytes
+
+    void grow(size_t needed) {
+        reallocate(std::max({needed, capacity_ + capacity_ / 2, size_t(8)}));
+    }
+
+    // Move the buffer to exactly new_capacity elements (mappings round up to whole pages)
+    void reallocate(size_t new_capacity) {
+        if (new_capacity > SIZE_MAX / sizeof(T)) throw std::bad_alloc();
+        size_t old_bytes = capacity_ * sizeof(T);
+        size_t new_bytes = new_capacity * sizeof(T);
+        void* memory = nullptr;
+        bool new_mapped = false;
+
+        if (new_bytes == 0) {
+            release(data_, old_bytes, mapped);
+        }
+#ifdef __linux__
+        else if (new_bytes >= map_threshold) {
+            size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            new_bytes = (new_bytes + page - 1) / page * page;
+            new_mapped = true;
+            if (mapped) {
+                memory = ::mremap(data_, old_bytes, new_bytes, MREMAP_MAYMOVE);
+            } else {
+                memory = ::mmap(nullptr, new_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (memory != MAP_FAILED && size_) std::memcpy(memory, data_, size_ * sizeof(T));
+                if (memory != MAP_FAILED) release(data_, old_bytes, false);
+            }
+            if (memory == MAP_FAILED) throw std::bad_alloc();
+        } else if (mapped) {
+            // Dropping below the threshold: back to the heap
+            memory = std::malloc(new_bytes);
+            if (!memory) throw std::bad_alloc();
+            std::memcpy(memory, data_, std::min(size_, new_capacity) * sizeof(T));
+            release(data_, old_bytes, true);
+        }
+#endif
+        else {
+            memory = std::realloc(data_, new_bytes);
+            if (!memory) throw std::bad_alloc();
+        }
+
+        data_ = static_cast<T*>(memory);
+        capacity_ = new_bytes / sizeof(T);
+        size_ = std::min(size_, capacity_);
+        mapped = new_mapped;
+    }
+
+    static void release(void* memory, size_t bytes, bool is_mapped) {
+        if (!memory) return;
+#ifdef __linux__
+        if (is_mapped) {
+            ::munmap(memory, bytes);
+            return;
+        }
+#endif
+        (void)bytes;
+        (void)is_mapped;
+        std::free(memory);
+    }
+
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    bool mapped = false;               // data_ is an mmap'd region rather than a malloc block
+};
+
+void growableBufferExample() {
+    GrowableBuffer<int> numbers;
+    for (int i = 0; i < 10; ++i) {
+        numbers.push_back(i + 1);      // the 5 -> 10 growth of memory_management_realloc, automatically
+    }
+    for (int value : numbers) {
+        std::cout << value << " ";
+    }
+    std::cout << "\nsize " << numbers.size() << ", capacity " << numbers.capacity() << "\n";
+
+    numbers.resize(1 << 20);           // 4 MiB: moves into its own mapping, grown from now on by mremap
+    numbers.resize(10);
+    numbers.shrink_to_fit();           // and back to a small heap block
+    std::cout << "after shrink: capacity " << numbers.capacity() << "\n";
+}
+
 /*
 Dynamic memory allocation in c++
 new: Allocates memory on heap.
@@ -170,6 +366,303 @@ int dynamic_memory_allocation_new() {
 
     return 0;
 }
+
+/*
+Allocation Tracking (opt-in, build with -DTRACK_ALLOCATIONS):
+Replacing the global operator new/delete is the standard way to see what a program really
+allocates, without a profiler. With the flag set, every new/delete in the program (including
+those made by std::vector, std::string, ...) is counted:
+🔹 Per size class: allocations and bytes, in power-of-two classes (<= 16, <= 32, ... bytes).
+🔹 Live and peak bytes. Each thread batches its changes and publishes them every 64 KiB,
+   so the peak is exact to within 64 KiB per thread.
+🔹 Call sites: about once per 512 KiB allocated, a thread records the stack of the allocation
+   it is making; the report lists the hottest stacks (glibc only).
+🔹 The counters belong to the thread that allocates (one cache-line aligned block per
+   thread, up to 256 threads), so counting needs no locks and no lock-prefixed instructions.
+🔹 A report is written to stderr at exit, and whenever the process receives SIGUSR1.
+Each block carries a 16-byte header (more for over-aligned types) that remembers its size,
+so unsized delete can still be counted.
+*/
+#ifdef TRACK_ALLOCATIONS
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
+#include <cstddef>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#endif
+
+namespace allocation_tracking {
+
+constexpr int size_classes = 40;               // class k holds sizes in (2^(k-1), 2^k], class 4 everything <= 16
+constexpr int max_threads = 256;
+constexpr int64_t publish_threshold = 64 * 1024;
+constexpr uint64_t sample_interval = 512 * 1024;
+constexpr int max_frames = 16;
+constexpr int max_sites = 512;
+
+struct alignas(64) ThreadCounters {
+    std::atomic<uint64_t> count[size_classes];
+    std::atomic<uint64_t> bytes[size_classes];
+    std::atomic<uint64_t> frees;
+    std::atomic<uint64_t> freed_bytes;
+};
+
+// One block per thread plus a shared block for threads beyond max_threads
+ThreadCounters counters[max_threads + 1];
+std::atomic<int> next_thread{0};
+std::atomic<int64_t> live_bytes{0};
+std::atomic<int64_t> peak_bytes{0};
+
+struct Site {
+    void* frames[max_frames];
+    int depth;
+    uint64_t samples;
+    uint64_t estimated_bytes;                  // each sample stands for max(size, sample_interval) bytes
+};
+Site sites[max_sites];
+std::mutex sites_mutex;
+
+// Per-thread state is plain data, so touching it never allocates
+struct ThreadState {
+    ThreadCounters* counters = nullptr;
+    bool shared = false;
+    int64_t pending_bytes = 0;                 // live-byte change not yet published
+    uint64_t until_sample = sample_interval;
+    bool sampling = false;                     // inside backtrace(): don't recurse
+};
+thread_local ThreadState state;
+
+inline int sizeClass(size_t size) {
+    int k = 4;
+    while (k < size_classes - 1 && (size_t(1) << k) < size) ++k;
+    return k;
+}
+
+inline void add(std::atomic<uint64_t>& counter, uint64_t value) {
+    // Owned blocks have a single writer, so a plain load and store is enough
+    if (state.shared) counter.fetch_add(value, std::memory_order_relaxed);
+    else counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+inline ThreadCounters& mine() {
+    if (!state.counters) {
+        int index = next_thread.fetch_add(1, std::memory_order_relaxed);
+        state.shared = index >= max_threads;
+        state.counters = &counters[state.shared ? max_threads : index];
+    }
+    return *state.counters;
+}
+
+inline void publish(int64_t delta) {
+    state.pending_bytes += delta;
+    if (state.pending_bytes < publish_threshold && state.pending_bytes > -publish_threshold) return;
+    int64_t now = live_bytes.fetch_add(state.pending_bytes, std::memory_order_relaxed) + state.pending_bytes;
+    state.pending_bytes = 0;
+    int64_t peak = peak_bytes.load(std::memory_order_relaxed);
+    while (now > peak && !peak_bytes.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+}
+
+void sample(size_t size) {
+#if defined(__GLIBC__)
+    state.sampling = true;
+    void* frames[max_frames + 2];
+    int depth = backtrace(frames, max_frames + 2) - 2;   // drop sample() and the allocation function
+    state.sampling = false;
+    if (depth <= 0) return;
+
+    uint64_t hash = 1469598103934665603ull;
+    for (int i = 0; i < depth; ++i) hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i + 2])) * 1099511628211ull;
+
+    std::lock_guard<std::mutex> lock(sites_mutex);
+    for (int probe = 0; probe < max_sites; ++probe) {
+        Site& site = sites[(hash + probe) % max_sites];
+        if (site.depth == 0) {
+            memcpy(site.frames, frames + 2, depth * sizeof(void*));
+            site.depth = depth;
+        } else if (site.depth != depth || memcmp(site.frames, frames + 2, depth * sizeof(void*)) != 0) {
+            continue;
+        }
+        site.samples += 1;
+        site.estimated_bytes += size > sample_interval ? size : sample_interval;
+        return;
+    }
+#else
+    (void)size;
+#endif
+}
+
+// Header stored right before every block: the requested size and the distance back to
+// the start of the underlying malloc block
+struct Header {
+    size_t size;
+    size_t offset;
+};
+
+void* allocate(size_t size, size_t alignment, bool nothrow) {
+    size_t offset = alignment > sizeof(Header) ? alignment : sizeof(Header);
+    void* raw;
+    while (true) {
+        if (alignment <= alignof(std::max_align_t)) raw = std::malloc(size + offset);
+        else raw = std::aligned_alloc(alignment, (size + offset + alignment - 1) / alignment * alignment);
+        if (raw) break;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            if (nothrow) return nullptr;
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+    char* user = static_cast<char*>(raw) + offset;
+    reinterpret_cast<Header*>(user)[-1] = {size, offset};
+
+    ThreadCounters& c = mine();
+    int k = sizeClass(size);
+    add(c.count[k], 1);
+    add(c.bytes[k], size);
+    publish(static_cast<int64_t>(size));
+    if (!state.sampling && (state.until_sample <= size || (state.until_sample -= size) == 0)) {
+        state.until_sample = sample_interval;
+        sample(size);
+    }
+    return user;
+}
+
+void release(void* p) {
+    if (!p) return;
+    Header header = reinterpret_cast<Header*>(p)[-1];
+    ThreadCounters& c = mine();
+    add(c.frees, 1);
+    add(c.freed_bytes, header.size);
+    publish(-static_cast<int64_t>(header.size));
+    std::free(static_cast<char*>(p) - header.offset);
+}
+
+// Report writer that only uses a stack buffer and write(2), so it is usable in a signal handler
+class ReportWriter {
+public:
+    ~ReportWriter() { flush(); }
+    ReportWriter& operator<<(const char* text) {
+        while (*text) put(*text++);
+        return *this;
+    }
+    ReportWriter& operator<<(uint64_t value) {
+        char digits[24];
+        int n = 0;
+        do { digits[n++] = char('0' + value % 10); value /= 10; } while (value);
+        while (n) put(digits[--n]);
+        return *this;
+    }
+    void flush() {
+        for (size_t done = 0; done < used;) {
+            ssize_t n = ::write(STDERR_FILENO, buffer + done, used - done);
+            if (n <= 0) break;
+            done += static_cast<size_t>(n);
+        }
+        used = 0;
+    }
+
+private:
+    void put(char c) {
+        if (used == sizeof(buffer)) flush();
+        buffer[used++] = c;
+    }
+    char buffer[4096];
+    size_t used = 0;
+};
+
+void report() {
+    uint64_t count[size_classes] = {}, bytes[size_classes] = {}, frees = 0, freed = 0, total = 0, total_bytes = 0;
+    for (auto& c : counters) {
+        for (int k = 0; k < size_classes; ++k) {
+            count[k] += c.count[k].load(std::memory_order_relaxed);
+            bytes[k] += c.bytes[k].load(std::memory_order_relaxed);
+        }
+        frees += c.frees.load(std::memory_order_relaxed);
+        freed += c.freed_bytes.load(std::memory_order_relaxed);
+    }
+    for (int k = 0; k < size_classes; ++k) {
+        total += count[k];
+        total_bytes += bytes[k];
+    }
+
+    ReportWriter out;
+    out << "\n=== Allocation Report ===\n";
+    out << "Allocations: " << total << " (" << total_bytes << " bytes), frees: " << frees << " (" << freed << " bytes)\n";
+    out << "Live: " << (total_bytes - freed) << " bytes, peak: ~" << uint64_t(peak_bytes.load(std::memory_order_relaxed)) << " bytes\n";
+    out << "Size class (<= bytes)  Count  Bytes\n";
+    for (int k = 0; k < size_classes; ++k) {
+        if (count[k]) out << (uint64_t(1) << k) << "  " << count[k] << "  " << bytes[k] << "\n";
+    }
+
+#if defined(__GLIBC__)
+    // A signal may arrive while this thread holds the lock; skip the sites rather than deadlock
+    std::unique_lock<std::mutex> lock(sites_mutex, std::try_to_lock);
+    if (!lock) return;
+    int order[10];
+    int shown = 0;
+    for (; shown < 10; ++shown) {
+        int best = -1;
+        for (int i = 0; i < max_sites; ++i) {
+            bool taken = false;
+            for (int j = 0; j < shown; ++j) taken |= order[j] == i;
+            if (!taken && sites[i].samples && (best < 0 || sites[i].estimated_bytes > sites[best].estimated_bytes)) best = i;
+        }
+        if (best < 0) break;
+        order[shown] = best;
+    }
+    if (shown) out << "Hottest sampled call sites (one sample per ~" << sample_interval / 1024 << " KiB allocated):\n";
+    for (int i = 0; i < shown; ++i) {
+        const Site& site = sites[order[i]];
+        out << "#" << uint64_t(i + 1) << " samples: " << site.samples << ", ~" << site.estimated_bytes << " bytes\n";
+        out.flush();
+        backtrace_symbols_fd(const_cast<void* const*>(site.frames), site.depth, STDERR_FILENO);
+    }
+#endif
+}
+
+void reportOnSignal(int) { report(); }
+
+// Installed during static initialization; counting itself works before this runs
+const bool installed = [] {
+#if defined(__GLIBC__)
+    void* warm_up[1];
+    backtrace(warm_up, 1);                     // loads the unwinder now, not inside an allocation
+#endif
+    std::signal(SIGUSR1, reportOnSignal);
+    std::atexit(report);
+    return true;
+}();
+
+}  // namespace allocation_tracking
+
+void* operator new(size_t size) { return allocation_tracking::allocate(size, 0, false); }
+void* operator new[](size_t size) { return allocation_tracking::allocate(size, 0, false); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocation_tracking::allocate(size, 0, true); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocation_tracking::allocate(size, 0, true); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocation_tracking::allocate(size, size_t(alignment), false); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocation_tracking::allocate(size, size_t(alignment), false); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocation_tracking::allocate(size, size_t(alignment), true); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocation_tracking::allocate(size, size_t(alignment), true); }
+
+void operator delete(void* p) noexcept { allocation_tracking::release(p); }
+void operator delete[](void* p) noexcept { allocation_tracking::release(p); }
+void operator delete(void* p, size_t) noexcept { allocation_tracking::release(p); }
+void operator delete[](void* p, size_t) noexcept { allocation_tracking::release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { allocation_tracking::release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { allocation_tracking::release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { allocation_tracking::release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { allocation_tracking::release(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { allocation_tracking::release(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { allocation_tracking::release(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { allocation_tracking::release(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { allocation_tracking::release(p); }
+#endif
 /*
 Effective memory management is crucial for writing robust, efficient, and leak-free applications, especially in languages like C++ that give you
 direct control over memory. Here are some best practices for memory management:
@@ -217,7 +710,8 @@ public:
     }
 
     // Accessor
-    int& operator[](size_t indexrn data[index];
+    int& operator[](size_t index) {
+        return data[index];
     }
 
     // Prevent copying (to avoid double deletion)
@@ -275,8 +769,572 @@ AddressSanitizer
 These help detect leaks and invalid memory access.
 🔹 7. Minimize Heap Allocations
 Prefer stack allocation when possible. Heap allocations are slower and more error-prone.
+When many short-lived objects are needed, an arena (below) turns thousands of heap
+allocations into a few.
 */
 
+/*
+Monotonic Arena:
+ScopedArray ties one fixed-size buffer to a scope. A monotonic arena applies the same RAII idea
+to many objects at once: memory is handed out from large chunks by bumping a pointer, and
+nothing is freed one object at a time. Everything is given back together by reset() or when
+the arena itself goes out of scope.
+🔹 Why: request-scoped work creates thousands of small objects that all die together, so
+   per-object new/delete is wasted work. A bump allocation is an add and a compare.
+🔹 Chunked growth: when the current chunk is full a new one is taken from the upstream
+   resource, each one twice as large as the previous, up to a cap.
+🔹 Alignment: every allocation is aligned as requested, so any type can live in the arena.
+🔹 std::pmr::memory_resource: containers like std::pmr::vector or std::pmr::string can
+   allocate from the arena directly. deallocate() is a no-op; memory returns on reset().
+🔹 Destructors: create<T>() records a destructor for types that need one, and reset()
+   runs them in reverse creation order. Trivially destructible types cost nothing extra.
+🔹 reset() keeps the largest chunk for the next round; release() returns everything upstream.
+Like std::pmr::monotonic_buffer_resource, an arena is not thread-safe: use one per thread
+or per request.
+*/
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+
+class MonotonicArena : public std::pmr::memory_resource {
+public:
+    explicit MonotonicArena(size_t initial_chunk_size = 4096,
+                            std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream(upstream), next_chunk_size(std::max(initial_chunk_size, sizeof(Chunk) * 2)) {}
+
+    ~MonotonicArena() override { release(); }
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    // Construct a T in the arena. Its destructor (if it has one) runs on reset()/release().
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        if constexpr (std::is_trivially_destructible_v<T>) {
+            return new (memory) T(std::forward<Args>(args)...);
+        } else {
+            // Take the cleanup record first, so nothing can fail once the object exists
+            auto* cleanup = static_cast<Cleanup*>(allocate(sizeof(Cleanup), alignof(Cleanup)));
+            T* object = new (memory) T(std::forward<Args>(args)...);
+            *cleanup = Cleanup{[](void* p) { static_cast<T*>(p)->~T(); }, object, cleanups};
+            cleanups = cleanup;
+            return object;
+        }
+    }
+
+    // Uninitialized storage for n objects of type T
+    template <typename T>
+    T* allocateArray(size_t n) {
+        if (n > SIZE_MAX / sizeof(T)) throw std::bad_alloc();
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // Run pending destructors and rewind, keeping the largest chunk for reuse
+    void reset() {
+        runCleanups();
+        Chunk* keep = chunks;
+        for (Chunk* chunk = chunks; chunk; chunk = chunk->next) {
+            if (chunk->size > keep->size) keep = chunk;
+        }
+        while (chunks) {
+            Chunk* next = chunks->next;
+            if (chunks != keep) upstream->deallocate(chunks, chunks->size, alignof(std::max_align_t));
+            chunks = next;
+        }
+        chunks = keep;
+        if (keep) {
+            keep->next = nullptr;
+            current = reinterpret_cast<char*>(keep + 1);
+            end = reinterpret_cast<char*>(keep) + keep->size;
+        } else {
+            current = end = nullptr;
+        }
+        bytes_used = 0;
+    }
+
+    // Run pending destructors and return every chunk to the upstream resource
+    void release() {
+        runCleanups();
+        while (chunks) {
+            Chunk* next = chunks->next;
+            upstream->deallocate(chunks, chunks->size, alignof(std::max_align_t));
+            chunks = next;
+        }
+        current = end = nullptr;
+        bytes_used = 0;
+    }
+
+    size_t bytesUsed() const { return bytes_used; }       // requested since the last reset
+
+    size_t chunkCount() const {
+        size_t count = 0;
+        for (Chunk* chunk = chunks; chunk; chunk = chunk->next) ++count;
+        return count;
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        char* aligned = alignUp(current, alignment);
+        // Compared as addresses: a large alignment can push aligned past end
+        auto aligned_address = reinterpret_cast<std::uintptr_t>(aligned);
+        auto end_address = reinterpret_cast<std::uintptr_t>(end);
+        if (!current || aligned_address > end_address || bytes > end_address - aligned_address) {
+            addChunk(bytes, alignment);
+            aligned = alignUp(current, alignment);
+        }
+        current = aligned + bytes;
+        bytes_used += bytes;
+        return aligned;
+    }
+
+    // Individual frees are ignored; memory comes back on reset() or release()
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    struct alignas(std::max_align_t) Chunk {
+        Chunk* next;
+        size_t size;                   // including this header
+    };
+
+    struct Cleanup {
+        void (*destroy)(void*);
+        void* object;
+        Cleanup* next;
+    };
+
+    static constexpr size_t max_chunk_size = size_t(64) << 20;
+
+    static char* alignUp(char* p, size_t alignment) {
+        auto address = reinterpret_cast<std::uintptr_t>(p);
+        return reinterpret_cast<char*>((address + alignment - 1) & ~(std::uintptr_t(alignment) - 1));
+    }
+
+    void addChunk(size_t bytes, size_t alignment) {
+        if (bytes > SIZE_MAX - sizeof(Chunk) - alignment) throw std::bad_alloc();
+        size_t needed = sizeof(Chunk) + bytes + alignment;
+        size_t size = std::max(next_chunk_size, needed);
+        auto* chunk = static_cast<Chunk*>(upstream->allocate(size, alignof(std::max_align_t)));
+        chunk->next = chunks;
+        chunk->size = size;
+        chunks = chunk;
+        current = reinterpret_cast<char*>(chunk + 1);
+        end = reinterpret_cast<char*>(chunk) + size;
+        next_chunk_size = std::min(next_chunk_size * 2, max_chunk_size);
+    }
+
+    void runCleanups() {
+        while (cleanups) {
+            Cleanup* cleanup = cleanups;
+            cleanups = cleanup->next;
+            cleanup->destroy(cleanup->object);
+        }
+    }
+
+    std::pmr::memory_resource* upstream;
+    size_t next_chunk_size;
+    Chunk* chunks = nullptr;
+    char* current = nullptr;
+    char* end = nullptr;
+    size_t bytes_used = 0;
+    Cleanup* cleanups = nullptr;
+};
+
+void arenaExample() {
+    MonotonicArena arena;
+    {
+        // Containers allocate straight from the arena
+        std::pmr::vector<int> values(&arena);
+        for (int i = 0; i < 1000; ++i) {
+            values.push_back(i);
+        }
+
+        // Individual objects of any type, destroyed on reset()
+        struct Point { double x, y; };
+        Point* p = arena.create<Point>(Point{1.5, 2.5});
+        auto* name = arena.create<std::pmr::string>("a string long enough to need heap storage", &arena);
+
+        std::cout << "Point: " << p->x << ", " << p->y << ", name: " << *name << "\n";
+        std::cout << "Arena: " << arena.bytesUsed() << " bytes in " << arena.chunkCount() << " chunks\n";
+    }
+    arena.reset();   // one step frees everything above
+    std::cout << "After reset: " << arena.chunkCount() << " chunk kept\n";
+}
+
+/*
+Object Pool:
+The arena suits objects that all die together. Objects that come and go independently, but
+always have the same size, suit a pool: memory is carved into fixed-size slots, and a freed
+slot is simply pushed on a free list, ready for the next object of that type.
+🔹 Slabs: slots are allocated 256 at a time in one block (a slab), never one by one.
+🔹 Thread-local free lists: each thread allocates from and frees to its own list, without
+   locks or atomics on the common path.
+🔹 Batched return: when a thread's list grows past two batches, one batch of 64 slots moves
+   to the global list under a single lock; an empty thread list takes a whole batch back.
+   Memory freed on one thread is therefore reused by the others, a batch at a time.
+🔹 make_pooled<T>(args...) builds a T in a slot and returns a std::unique_ptr whose deleter
+   destroys the object and returns the slot to the pool.
+Slabs stay with the pool for the life of the program; they are reused, not handed back to
+the system.
+*/
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <iostream>
+
+template <typename T>
+class ObjectPool {
+public:
+    // The pool for T. It is never destroyed, so objects may be released during static
+    // destruction or from threads that outlive main. Once the calling thread's free
+    // list is gone (thread exit; on the main thread, before static destruction) slots
+    // go to and come from the global list directly, one at a time under the lock.
+    static ObjectPool& instance() {
+        static ObjectPool* pool = new ObjectPool();
+        return *pool;
+    }
+
+    // An uninitialized slot with room for one T
+    void* acquire() {
+        LocalList* local = localList();
+        if (!local) return takeOne();
+        if (!local->head) refill(*local);
+        Slot* slot = local->head;
+        local->head = slot->next;
+        --local->count;
+        return slot;
+    }
+
+    // Give back a slot from acquire() whose object has already been destroyed
+    void release(void* memory) {
+        auto* slot = static_cast<Slot*>(memory);
+        LocalList* local = localList();
+        if (!local) {
+            slot->next = nullptr;
+            std::lock_guard<std::mutex> lock(mutex);
+            batches.push_back({slot, 1});
+            return;
+        }
+        slot->next = local->head;
+        local->head = slot;
+        if (++local->count >= 2 * batch_size) giveBack(*local, batch_size);
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    // A chain of count slots linked through next
+    struct Batch {
+        Slot* head;
+        size_t count;
+    };
+
+    // The calling thread's free list. Whatever is left when the thread exits goes back
+    // to the global list.
+    struct LocalList {
+        Slot* head = nullptr;
+        size_t count = 0;
+        ~LocalList() {
+            local_list_destroyed = true;
+            if (count) ObjectPool::instance().giveBack(*this, count);
+        }
+    };
+
+    // Trivially destructible, so it stays readable after the thread's LocalList is gone
+    static inline thread_local bool local_list_destroyed = false;
+
+    static constexpr size_t batch_size = 64;
+    static constexpr size_t slab_size = 256;     // slots per slab
+
+    ObjectPool() = default;
+
+    // The calling thread's list, or nullptr once it has been destroyed
+    static LocalList* localList() {
+        if (local_list_destroyed) return nullptr;
+        thread_local LocalList local;
+        return &local;
+    }
+
+    // Detach the first count slots of the local list and push them as one global batch
+    void giveBack(LocalList& local, size_t count) {
+        Slot* head = local.head;
+        Slot* tail = head;
+        for (size_t i = 1; i < count; ++i) tail = tail->next;
+        local.head = tail->next;
+        local.count -= count;
+        tail->next = nullptr;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        batches.push_back({head, count});
+    }
+
+    // Move one batch from the global list into an empty local list, carving a new slab
+    // into batches first if the global list is empty
+    void refill(LocalList& local) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (batches.empty()) addSlab();
+        Batch batch = batches.back();
+        batches.pop_back();
+        local.head = batch.head;
+        local.count = batch.count;
+    }
+
+    // One slot straight from the global list, for threads without a local list
+    Slot* takeOne() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (batches.empty()) addSlab();
+        Batch& batch = batches.back();
+        Slot* slot = batch.head;
+        batch.head = slot->next;
+        if (--batch.count == 0) batches.pop_back();
+        return slot;
+    }
+
+    // Carve a new slab into global batches; the caller holds the mutex
+    void addSlab() {
+        slabs.emplace_back(new Slot[slab_size]);
+        Slot* slab = slabs.back().get();
+        for (size_t first = 0; first < slab_size; first += batch_size) {
+            size_t count = std::min(batch_size, slab_size - first);
+            for (size_t i = first; i + 1 < first + count; ++i) slab[i].next = &slab[i + 1];
+            slab[first + count - 1].next = nullptr;
+            batches.push_back({&slab[first], count});
+        }
+    }
+
+    std::mutex mutex;
+    std::vector<Batch> batches;
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+};
+
+// Deleter used by make_pooled: destroys the object and returns its slot to the pool
+template <typename T>
+struct PoolDeleter {
+    void operator()(T* object) const {
+        object->~T();
+        ObjectPool<T>::instance().release(object);
+    }
+};
+
+template <typename T>
+using pooled_ptr = std::unique_ptr<T, PoolDeleter<T>>;
+
+template <typename T, typename... Args>
+pooled_ptr<T> make_pooled(Args&&... args) {
+    ObjectPool<T>& pool = ObjectPool<T>::instance();
+    void* slot = pool.acquire();
+    try {
+        return pooled_ptr<T>(new (slot) T(std::forward<Args>(args)...));
+    } catch (...) {
+        pool.release(slot);
+        throw;
+    }
+}
+
+void pooledExample() {
+    struct Connection {
+        int id;
+        std::string host;
+        Connection(int id, std::string host) : id(id), host(std::move(host)) {}
+    };
+
+    std::vector<pooled_ptr<Connection>> open;
+    for (int i = 0; i < 5; ++i) {
+        open.push_back(make_pooled<Connection>(i, "host-" + std::to_string(i)));
+    }
+    std::cout << "Pooled connection " << open[2]->id << " to " << open[2]->host << "\n";
+
+    open.clear();   // slots go back to this thread's free list, ready for the next make_pooled
+    auto again = make_pooled<Connection>(7, "reused");
+    std::cout << "Reused slot for connection " << again->id << "\n";
+}
+
+/*
+Large Buffers (huge pages and NUMA):
+new int[n] is fine for small arrays, but a multi-GB table allocated that way is backed by 4 KiB
+pages and lands on whichever NUMA node first touches each page. LargeBuffer is a RAII owner
+of one big anonymous mapping that fixes both:
+🔹 Transparent huge pages: the region is 2 MiB aligned and marked with madvise(MADV_HUGEPAGE),
+   so the kernel can back it with 2 MiB pages. One TLB entry then covers 512 times more memory.
+🔹 NUMA binding: with numa_node >= 0, mbind() restricts the pages to that node, so threads
+   pinned there never reach across sockets. Machines with a single node (or kernels that refuse
+   the call) skip the binding; numaNode() reports whether it happened.
+🔹 Pre-faulting: prefault = true commits every page up front (MADV_POPULATE_WRITE, or touching
+   one byte per page on older kernels), moving page-fault cost out of the hot path. Binding and
+   advice are applied first, so the pages are faulted where and how they were asked for.
+Elsewhere than Linux the buffer is a plain aligned heap allocation with the same interface.
+Memory starts zeroed either way.
+*/
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <cstdint>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <dirent.h>
+#endif
+
+struct LargeBufferOptions {
+    bool huge_pages = true;            // align to 2 MiB and ask for transparent huge pages
+    bool prefault = false;             // commit all pages in the constructor
+    int numa_node = -1;                // bind to this node; -1 leaves placement to the kernel
+};
+
+class LargeBuffer {
+public:
+    explicit LargeBuffer(size_t bytes, const LargeBufferOptions& options = LargeBufferOptions())
+        : length(roundUp(bytes, options.huge_pages ? huge_page_size : page_size())) {
+        if (length == 0) return;
+#ifdef __linux__
+        // Over-map by one huge page so a 2 MiB aligned start can be cut out of the region
+        size_t slack = options.huge_pages ? huge_page_size : 0;
+        void* raw = ::mmap(nullptr, length + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) throw std::bad_alloc();
+        char* start = static_cast<char*>(raw);
+        char* aligned = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(start), slack ? slack : 1));
+        if (aligned > start) ::munmap(start, aligned - start);
+        if (start + slack > aligned) ::munmap(aligned + length, start + slack - aligned);
+        memory = aligned;
+
+        if (options.huge_pages) huge_pages = ::madvise(memory, length, MADV_HUGEPAGE) == 0;
+        if (options.numa_node >= 0 && options.numa_node < 64 && numaNodeCount() > 1) {
+            unsigned long node_mask = 1ul << options.numa_node;
+            const int mpol_bind = 2;   // MPOL_BIND from <linux/mempolicy.h>
+            if (::syscall(SYS_mbind, memory, length, mpol_bind, &node_mask, sizeof(node_mask) * 8, 0) == 0) {
+                bound_node = options.numa_node;
+            }
+        }
+        if (options.prefault) prefault();
+#else
+        memory = std::aligned_alloc(options.huge_pages ? huge_page_size : page_size(), length);
+        if (!memory) throw std::bad_alloc();
+        std::memset(memory, 0, length);
+#endif
+    }
+
+    ~LargeBuffer() { release(); }
+
+    LargeBuffer(const LargeBuffer&) = delete;
+    LargeBuffer& operator=(const LargeBuffer&) = delete;
+
+    LargeBuffer(LargeBuffer&& other) noexcept
+        : memory(std::exchange(other.memory, nullptr)), length(std::exchange(other.length, 0)),
+          huge_pages(other.huge_pages), bound_node(other.bound_node) {}
+
+    LargeBuffer& operator=(LargeBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            memory = std::exchange(other.memory, nullptr);
+            length = std::exchange(other.length, 0);
+            huge_pages = other.huge_pages;
+            bound_node = other.bound_node;
+        }
+        return *this;
+    }
+
+    void* data() { return memory; }
+    size_t size() const { return length; }      // the requested size rounded up to whole pages
+
+    template <typename T>
+    T* as() { return static_cast<T*>(memory); }
+
+    bool hugePages() const { return huge_pages; }   // the huge-page advice was accepted
+    int numaNode() const { return bound_node; }     // node the memory is bound to, or -1
+
+    // Number of NUMA nodes with memory; 1 when the system does not say
+    static int numaNodeCount() {
+        int count = 0;
+#ifdef __linux__
+        if (DIR* dir = ::opendir("/sys/devices/system/node")) {
+            while (dirent* entry = ::readdir(dir)) {
+                if (std::strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') ++count;
+            }
+            ::closedir(dir);
+        }
+#endif
+        return count > 0 ? count : 1;
+    }
+
+private:
+    static constexpr size_t huge_page_size = size_t(2) << 20;
+
+    static size_t page_size() {
+#ifdef __linux__
+        return static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+#else
+        return 4096;
+#endif
+    }
+
+    static size_t roundUp(size_t value, size_t multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+#ifdef __linux__
+    void prefault() {
+#ifdef MADV_POPULATE_WRITE
+        if (::madvise(memory, length, MADV_POPULATE_WRITE) == 0) return;
+#endif
+        // Older kernels: one write per page faults it in
+        volatile char* bytes = static_cast<char*>(memory);
+        for (size_t offset = 0; offset < length; offset += page_size()) bytes[offset] = 0;
+    }
+#endif
+
+    void release() {
+        if (!memory) return;
+#ifdef __linux__
+        ::munmap(memory, length);
+#else
+        std::free(memory);
+#endif
+        memory = nullptr;
+    }
+
+    void* memory = nullptr;
+    size_t length = 0;
+    bool huge_pages = false;
+    int bound_node = -1;
+};
+
+void largeBufferExample() {
+    LargeBufferOptions options;
+    options.prefault = true;
+    options.numa_node = 0;
+
+    LargeBuffer table(64 << 20, options);       // 64 MiB of ints, instead of new int[16 << 20]
+    int* values = table.as<int>();
+    size_t count = table.size() / sizeof(int);
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = static_cast<int>(i);
+    }
+
+    std::cout << "Large buffer: " << table.size() / (1 << 20) << " MiB, huge pages "
+              << (table.hugePages() ? "requested" : "unavailable") << ", NUMA node "
+              << (table.numaNode() >= 0 ? std::to_string(table.numaNode()) : std::string("not bound"))
+              << " of " << LargeBuffer::numaNodeCount() << "\n";
+}
+
 // Heap allocation.
 #include <iostream>
 
@@ -305,6 +1363,374 @@ void stackExample() {
 
     // Automatically deallocated when function ends
 }
+
+/*
+Allocation Benchmarks:
+heapExample and stackExample show the two kinds of storage; runAllocationBenchmarks puts numbers
+on the heap side. Every allocation strategy in this file is measured under the same workloads:
+🔹 Strategies: malloc, calloc, new, std::pmr pools (unsynchronized per thread, synchronized
+   shared), std::pmr::monotonic_buffer_resource, MonotonicArena and ObjectPool (fixed size only).
+🔹 Size distributions: fixed 64 bytes; uniform 8-256 bytes; mixed (90% 16-512 bytes, 10%
+   log-uniform up to 64 KiB).
+🔹 Patterns: "churn" keeps 16384 live blocks per thread and replaces a random one on each step;
+   "batch" allocates 16384 blocks, then frees them all (request-scoped work). A step is one
+   allocation and one free; in a batch each free is charged to the step that allocated the
+   block. Monotonic strategies cannot free single blocks, so they only run the batch pattern.
+🔹 Threads: each configuration runs with every count in thread_counts.
+🔹 Per configuration: throughput (million allocate+free pairs per second, timed over the steps
+   only, not the filling of the live set), p50/p99/p99.9
+   latency of a single allocate+free step, resident memory, and overhead = resident bytes
+   added / live bytes requested, measured while every thread holds its final live set.
+On Linux/Unix each configuration runs in a forked child, so every run starts with a fresh heap
+and the RSS numbers are not polluted by earlier runs. Latencies include the cost of reading the
+clock (printed with the results).
+*/
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <thread>
+#include <random>
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include <functional>
+#include <atomic>
+#include <iomanip>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+struct AllocationBenchmarkOptions {
+    size_t steps_per_thread = 200000;
+    std::vector<unsigned> thread_counts{1, std::max(2u, std::thread::hardware_concurrency())};
+};
+
+namespace allocation_benchmark {
+
+// One strategy as seen by the benchmark loop; each thread gets its own instance
+class Allocator {
+public:
+    virtual ~Allocator() = default;
+    virtual void* allocate(size_t size) = 0;
+    virtual void deallocate(void* p, size_t size) = 0;
+    virtual void endBatch() {}          // all blocks of the batch have been freed
+};
+
+class MallocAllocator : public Allocator {
+public:
+    void* allocate(size_t size) override { return std::malloc(size); }
+    void deallocate(void* p, size_t) override { std::free(p); }
+};
+
+class CallocAllocator : public Allocator {
+public:
+    void* allocate(size_t size) override { return std::calloc(1, size); }
+    void deallocate(void* p, size_t) override { std::free(p); }
+};
+
+class NewAllocator : public Allocator {
+public:
+    void* allocate(size_t size) override { return ::operator new(size); }
+    void deallocate(void* p, size_t size) override { ::operator delete(p, size); }
+};
+
+class ResourceAllocator : public Allocator {
+public:
+    explicit ResourceAllocator(std::pmr::memory_resource* resource) : resource(resource) {}
+    void* allocate(size_t size) override { return resource->allocate(size); }
+    void deallocate(void* p, size_t size) override { resource->deallocate(p, size); }
+protected:
+    std::pmr::memory_resource* resource;
+};
+
+// A resource owned by the thread, e.g. an unsynchronized pool or an arena
+template <typename Resource>
+class OwnedResourceAllocator : public ResourceAllocator {
+public:
+    OwnedResourceAllocator() : ResourceAllocator(nullptr) { resource = &owned; }
+    void endBatch() override {
+        if constexpr (std::is_same_v<Resource, MonotonicArena>) owned.reset();
+        else if constexpr (std::is_same_v<Resource, std::pmr::monotonic_buffer_resource>) owned.release();
+    }
+private:
+    Resource owned;
+};
+
+struct Block64 {
+    unsigned char bytes[64];
+};
+
+class PoolAllocator : public Allocator {
+public:
+    void* allocate(size_t) override { return ObjectPool<Block64>::instance().acquire(); }
+    void deallocate(void* p, size_t) override { ObjectPool<Block64>::instance().release(p); }
+};
+
+struct Strategy {
+    const char* name;
+    bool monotonic;                     // cannot free single blocks: batch pattern only
+    bool fixed_64_only;
+    std::function<std::unique_ptr<Allocator>(std::pmr::memory_resource* shared)> make;
+};
+
+struct Distribution {
+    const char* name;
+    std::function<uint32_t(std::mt19937&)> next;
+};
+
+struct Result {
+    double million_steps_per_second;
+    double p50_ns, p99_ns, p999_ns;
+    double rss_mib;
+    double overhead;
+};
+
+inline size_t residentBytes() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    size_t total = 0, resident = 0;
+    statm >> total >> resident;
+    return resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+inline Result run(const Strategy& strategy, const Distribution& sizes, bool churn, unsigned threads, size_t steps) {
+    using clock = std::chrono::steady_clock;
+    const size_t live_per_thread = 16384;
+    if (steps == 0 || threads == 0) throw std::invalid_argument("allocation benchmark needs steps and threads");
+
+    // Everything the timed loop touches is prepared up front, outside the measurement
+    std::vector<std::vector<uint32_t>> size_plan(threads), latencies(threads);
+    std::vector<std::vector<uint32_t>> victim_plan(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        std::mt19937 rng(1234 + t);
+        size_plan[t].resize(steps + live_per_thread);
+        for (auto& size : size_plan[t]) size = sizes.next(rng);
+        victim_plan[t].resize(steps);
+        for (auto& victim : victim_plan[t]) victim = static_cast<uint32_t>(rng() % live_per_thread);
+        latencies[t].resize(steps);
+    }
+
+    std::pmr::synchronized_pool_resource shared_pool;
+    std::atomic<unsigned> ready{0}, filled{0}, holding{0};
+    std::atomic<bool> go{false}, release_all{false};
+    std::vector<uint64_t> live_bytes(threads);
+    size_t rss_before = 0;
+    // Each thread's timed window covers exactly its steps; the initial and final fills
+    // of the live set are not steps and stay outside it
+    std::vector<clock::time_point> starts(threads), finishes(threads);
+    // Write one byte per page, so large blocks are resident like they would be in real use
+    auto touch = [](void* p, size_t size) {
+        for (size_t offset = 0; offset < size; offset += 4096) static_cast<volatile unsigned char*>(p)[offset] = 1;
+    };
+    auto elapsed = [](clock::time_point begin) {
+        return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - begin).count());
+    };
+
+    auto worker = [&](unsigned t) {
+        std::unique_ptr<Allocator> allocator = strategy.make(&shared_pool);
+        std::vector<std::pair<void*, uint32_t>> live(live_per_thread, {nullptr, 0});
+        const uint32_t* plan = size_plan[t].data();
+        uint32_t* latency = latencies[t].data();
+
+        auto fill = [&] {
+            for (auto& block : live) {
+                block.second = *plan++;
+                block.first = allocator->allocate(block.second);
+                touch(block.first, block.second);
+            }
+        };
+        auto drain = [&] {
+            for (auto& block : live) allocator->deallocate(block.first, block.second);
+            allocator->endBatch();
+        };
+
+        ready.fetch_add(1);
+        while (!go.load()) std::this_thread::yield();
+
+        if (churn) {
+            fill();
+            // Start the timed steps together, once every thread holds its live set
+            filled.fetch_add(1);
+            while (filled.load() < threads) std::this_thread::yield();
+            starts[t] = clock::now();
+            for (size_t i = 0; i < steps; ++i) {
+                auto& block = live[victim_plan[t][i]];
+                auto begin = clock::now();
+                allocator->deallocate(block.first, block.second);
+                block.second = plan[i];
+                block.first = allocator->allocate(block.second);
+                touch(block.first, block.second);
+                latency[i] = elapsed(begin);
+            }
+            finishes[t] = clock::now();
+        } else {
+            starts[t] = clock::now();
+            for (size_t i = 0; i < steps;) {
+                size_t first = i;
+                size_t count = std::min(live_per_thread, steps - i);
+                for (size_t k = 0; k < count; ++k, ++i) {
+                    auto begin = clock::now();
+                    live[k].second = plan[i];
+                    live[k].first = allocator->allocate(live[k].second);
+                    touch(live[k].first, live[k].second);
+                    latency[i] = elapsed(begin);
+                }
+                for (size_t k = 0; k < count; ++k) {
+                    auto begin = clock::now();
+                    allocator->deallocate(live[k].first, live[k].second);
+                    latency[first + k] += elapsed(begin);
+                }
+                auto begin = clock::now();
+                allocator->endBatch();
+                latency[i - 1] += elapsed(begin);
+            }
+            finishes[t] = clock::now();
+            plan += steps;
+            fill();
+        }
+
+        // Hold the final live set while the resident size is sampled
+        uint64_t bytes = 0;
+        for (auto& block : live) bytes += block.second;
+        live_bytes[t] = bytes;
+        holding.fetch_add(1);
+        while (!release_all.load()) std::this_thread::yield();
+        drain();
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) workers.emplace_back(worker, t);
+    while (ready.load() < threads) std::this_thread::yield();
+    rss_before = residentBytes();
+    go.store(true);
+    while (holding.load() < threads) std::this_thread::yield();
+    size_t rss_after = residentBytes();
+    release_all.store(true);
+    for (auto& w : workers) w.join();
+
+    std::vector<uint32_t> all;
+    all.reserve(steps * threads);
+    for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    auto percentile = [&all](double p) {
+        auto nth = all.begin() + static_cast<std::ptrdiff_t>(p * double(all.size() - 1));
+        std::nth_element(all.begin(), nth, all.end());
+        return double(*nth);
+    };
+
+    Result result{};
+    clock::time_point start = *std::min_element(starts.begin(), starts.end());
+    clock::time_point finish = *std::max_element(finishes.begin(), finishes.end());
+    double seconds = std::chrono::duration<double>(finish - start).count();
+    result.million_steps_per_second = double(steps * threads) / seconds / 1e6;
+    result.p50_ns = percentile(0.5);
+    result.p99_ns = percentile(0.99);
+    result.p999_ns = percentile(0.999);
+    uint64_t live_total = 0;
+    for (auto bytes : live_bytes) live_total += bytes;
+    result.rss_mib = double(rss_after) / (1 << 20);
+    result.overhead = rss_after > rss_before && live_total ? double(rss_after - rss_before) / double(live_total) : 0.0;
+    return result;
+}
+
+// Run one configuration in a child process when possible, so its heap starts out empty
+inline Result isolatedRun(const Strategy& strategy, const Distribution& sizes, bool churn, unsigned threads, size_t steps) {
+#if defined(__unix__) || defined(__APPLE__)
+    int fds[2];
+    if (::pipe(fds) == 0) {
+        pid_t child = ::fork();
+        if (child == 0) {
+            ::close(fds[0]);
+            Result result = run(strategy, sizes, churn, threads, steps);
+            ssize_t written = ::write(fds[1], &result, sizeof(result));
+            ::_exit(written == ssize_t(sizeof(result)) ? 0 : 1);
+        }
+        ::close(fds[1]);
+        Result result{};
+        bool ok = child > 0 && ::read(fds[0], &result, sizeof(result)) == ssize_t(sizeof(result));
+        ::close(fds[0]);
+        if (child > 0) ::waitpid(child, nullptr, 0);
+        if (ok) return result;
+    }
+#endif
+    return run(strategy, sizes, churn, threads, steps);
+}
+
+}  // namespace allocation_benchmark
+
+void runAllocationBenchmarks(std::ostream& out = std::cout,
+                             const AllocationBenchmarkOptions& options = AllocationBenchmarkOptions()) {
+    using namespace allocation_benchmark;
+
+    if (options.steps_per_thread == 0 ||
+        std::find(options.thread_counts.begin(), options.thread_counts.end(), 0u) != options.thread_counts.end()) {
+        throw std::invalid_argument("allocation benchmarks need at least one step and one thread");
+    }
+
+    std::vector<Strategy> strategies = {
+        {"malloc", false, false, [](std::pmr::memory_resource*) { return std::make_unique<MallocAllocator>(); }},
+        {"calloc", false, false, [](std::pmr::memory_resource*) { return std::make_unique<CallocAllocator>(); }},
+        {"new", false, false, [](std::pmr::memory_resource*) { return std::make_unique<NewAllocator>(); }},
+        {"pmr unsync pool", false, false, [](std::pmr::memory_resource*) {
+            return std::make_unique<OwnedResourceAllocator<std::pmr::unsynchronized_pool_resource>>(); }},
+        {"pmr sync pool", false, false, [](std::pmr::memory_resource* shared) {
+            return std::make_unique<ResourceAllocator>(shared); }},
+        {"object pool", false, true, [](std::pmr::memory_resource*) { return std::make_unique<PoolAllocator>(); }},
+        {"pmr monotonic", true, false, [](std::pmr::memory_resource*) {
+            return std::make_unique<OwnedResourceAllocator<std::pmr::monotonic_buffer_resource>>(); }},
+        {"arena", true, false, [](std::pmr::memory_resource*) {
+            return std::make_unique<OwnedResourceAllocator<MonotonicArena>>(); }},
+    };
+
+    std::vector<Distribution> distributions = {
+        {"fixed 64", [](std::mt19937&) { return uint32_t(64); }},
+        {"8-256", [](std::mt19937& rng) { return uint32_t(8 + rng() % 249); }},
+        {"mixed", [](std::mt19937& rng) {
+            if (rng() % 10) return uint32_t(16 + rng() % 497);
+            return uint32_t(std::exp2(9.0 + 7.0 * std::uniform_real_distribution<double>(0, 1)(rng)));
+        }},
+    };
+
+    // Cost of the two clock reads around every timed step
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100000; ++i) (void)std::chrono::steady_clock::now();
+    double clock_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / 100000;
+
+    out << "\n=== Allocation Benchmarks (" << options.steps_per_thread << " steps per thread, clock read ~"
+        << std::fixed << std::setprecision(0) << clock_ns << " ns) ===\n";
+    out << std::left << std::setw(17) << "Strategy" << std::setw(8) << "Pattern" << std::setw(10) << "Sizes"
+        << std::right << std::setw(4) << "Thr" << std::setw(10) << "Msteps/s" << std::setw(8) << "p50ns"
+        << std::setw(8) << "p99ns" << std::setw(9) << "p99.9ns" << std::setw(9) << "RSS MiB" << std::setw(10) << "Overhead" << "\n";
+    out << std::string(93, '-') << "\n";
+
+    for (bool churn : {true, false}) {
+        for (const auto& sizes : distributions) {
+            for (unsigned threads : options.thread_counts) {
+                for (const auto& strategy : strategies) {
+                    if (churn && strategy.monotonic) continue;
+                    if (strategy.fixed_64_only && std::string(sizes.name) != "fixed 64") continue;
+
+                    Result r = isolatedRun(strategy, sizes, churn, threads, options.steps_per_thread);
+                    out << std::left << std::setw(17) << strategy.name << std::setw(8) << (churn ? "churn" : "batch")
+                        << std::setw(10) << sizes.name << std::right << std::setw(4) << threads
+                        << std::setw(10) << std::setprecision(1) << r.million_steps_per_second
+                        << std::setw(8) << std::setprecision(0) << r.p50_ns << std::setw(8) << r.p99_ns
+                        << std::setw(9) << r.p999_ns << std::setw(9) << std::setprecision(1) << r.rss_mib
+                        << std::setw(10) << std::setprecision(2) << r.overhead << "\n";
+                }
+            }
+        }
+    }
+    out << std::defaultfloat;
+}
 /*
 🔹 8. Be Mindful of Object Lifetimes
 Ensure that objects are not accessed after they are destroyed. This is especially important when using raw pointers or references.
@@ -23,6 +23,8 @@ public:
     void greet() { std::cout << "Hello from MyClass\n"; }
 };
 
+void localSharedExample();   // single-threaded counterpart, defined below
+
 int main() {
     std::shared_ptr<MyClass> ptr1 = std::make_shared<MyClass>();
     {
@@ -32,6 +34,8 @@ int main() {
     } // ptr2 goes out of scope
 
     std::cout << "Use count after ptr2 is gone: " << ptr1.use_count() << "\n"; // 1
+
+    localSharedExample();
 } // ptr1 goes out of scope, object is destroyed
 
 /*
@@ -48,6 +52,253 @@ Overhead: Slightly more memory and performance overhead due to reference countin
 Not Thread-Safe for Object Access: While reference counting is thread-safe, access to the object itself is not.
 */
 
+/*
+local_shared_ptr: shared ownership without atomic reference counts
+std::shared_ptr keeps its counts with atomic instructions so that copies can be made and dropped on
+any thread. On x86 every copy and every destruction is then a lock-prefixed instruction, even in code
+that never leaves one thread. local_shared_ptr<T> has the same interface, but is for object graphs
+that stay on one thread:
+🔹 Plain (non-atomic) use and weak counts: copying is an ordinary increment.
+🔹 make_local_shared<T>(args...) puts the counts and the object in a single allocation, like
+   make_shared.
+🔹 local_weak_ptr<T> observes without owning: lock() gives back a local_shared_ptr (empty once the
+   object is gone), and expired() tells whether it is.
+🔹 use_count(), get(), reset(), swap(), conversion from local_shared_ptr<Derived> to local_shared_ptr<Base>.
+Never copy, reset or destroy local_shared_ptrs to one object from two threads at once; if the
+pointers have to cross threads, use std::shared_ptr.
+*/
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+namespace local_detail {
+
+// Counts shared by every local_shared_ptr/local_weak_ptr to one object. As with std::shared_ptr,
+// the owners together hold one weak reference, so the block outlives the object while
+// weak pointers remain.
+class ControlBlock {
+public:
+    long use_count = 1;
+    long weak_count = 1;
+
+    virtual void destroyObject() noexcept = 0;   // use_count reached zero
+    virtual void destroyBlock() noexcept = 0;    // weak_count reached zero
+
+    void addShared() noexcept { ++use_count; }
+    void addWeak() noexcept { ++weak_count; }
+
+    void releaseShared() noexcept {
+        if (--use_count == 0) {
+            destroyObject();
+            releaseWeak();
+        }
+    }
+    void releaseWeak() noexcept {
+        if (--weak_count == 0) destroyBlock();
+    }
+
+protected:
+    ~ControlBlock() = default;
+};
+
+// Object stored inside the block: the single allocation of make_local_shared
+template <typename T>
+class InlineBlock final : public ControlBlock {
+public:
+    template <typename... Args>
+    explicit InlineBlock(Args&&... args) {
+        ::new (static_cast<void*>(storage)) T(std::forward<Args>(args)...);
+    }
+    T* object() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+    void destroyObject() noexcept override { object()->~T(); }
+    void destroyBlock() noexcept override { delete this; }
+
+private:
+    alignas(T) unsigned char storage[sizeof(T)];
+};
+
+// Block for an object that was allocated separately with new
+template <typename T>
+class PointerBlock final : public ControlBlock {
+public:
+    explicit PointerBlock(T* p) noexcept : pointer(p) {}
+    void destroyObject() noexcept override { delete pointer; }
+    void destroyBlock() noexcept override { delete this; }
+
+private:
+    T* pointer;
+};
+
+}  // namespace local_detail
+
+template <typename T> class local_weak_ptr;
+
+template <typename T>
+class local_shared_ptr {
+public:
+    local_shared_ptr() noexcept = default;
+    local_shared_ptr(std::nullptr_t) noexcept {}
+
+    // Take ownership of an object created with new (two allocations; prefer make_local_shared)
+    template <typename U>
+    explicit local_shared_ptr(U* p) : pointer(p) {
+        try {
+            block = new local_detail::PointerBlock<U>(p);
+        } catch (...) {
+            delete p;
+            throw;
+        }
+    }
+
+    local_shared_ptr(const local_shared_ptr& other) noexcept : pointer(other.pointer), block(other.block) {
+        if (block) block->addShared();
+    }
+    local_shared_ptr(local_shared_ptr&& other) noexcept
+        : pointer(std::exchange(other.pointer, nullptr)), block(std::exchange(other.block, nullptr)) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    local_shared_ptr(const local_shared_ptr<U>& other) noexcept : pointer(other.pointer), block(other.block) {
+        if (block) block->addShared();
+    }
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    local_shared_ptr(local_shared_ptr<U>&& other) noexcept
+        : pointer(std::exchange(other.pointer, nullptr)), block(std::exchange(other.block, nullptr)) {}
+
+    ~local_shared_ptr() {
+        if (block) block->releaseShared();
+    }
+
+    // Copy first, release last: other may be owned by the object this pointer releases
+    // (p = p->next), so it must not be read after the old count drops
+    local_shared_ptr& operator=(const local_shared_ptr& other) noexcept {
+        local_shared_ptr(other).swap(*this);
+        return *this;
+    }
+
+    local_shared_ptr& operator=(local_shared_ptr&& other) noexcept {
+        local_shared_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept { local_shared_ptr().swap(*this); }
+
+    template <typename U>
+    void reset(U* p) { local_shared_ptr(p).swap(*this); }
+
+    void swap(local_shared_ptr& other) noexcept {
+        std::swap(pointer, other.pointer);
+        std::swap(block, other.block);
+    }
+
+    T* get() const noexcept { return pointer; }
+    T& operator*() const noexcept { return *pointer; }
+    T* operator->() const noexcept { return pointer; }
+    explicit operator bool() const noexcept { return pointer != nullptr; }
+    long use_count() const noexcept { return block ? block->use_count : 0; }
+
+private:
+    template <typename U> friend class local_shared_ptr;
+    template <typename U> friend class local_weak_ptr;
+    template <typename U, typename... Args> friend local_shared_ptr<U> make_local_shared(Args&&... args);
+
+    // Adopts one shared reference already counted in block
+    local_shared_ptr(T* p, local_detail::ControlBlock* b) noexcept : pointer(p), block(b) {}
+
+    T* pointer = nullptr;
+    local_detail::ControlBlock* block = nullptr;
+};
+
+template <typename T, typename U>
+bool operator==(const local_shared_ptr<T>& a, const local_shared_ptr<U>& b) noexcept { return a.get() == b.get(); }
+template <typename T, typename U>
+bool operator!=(const local_shared_ptr<T>& a, const local_shared_ptr<U>& b) noexcept { return a.get() != b.get(); }
+template <typename T>
+bool operator==(const local_shared_ptr<T>& a, std::nullptr_t) noexcept { return !a; }
+template <typename T>
+bool operator!=(const local_shared_ptr<T>& a, std::nullptr_t) noexcept { return static_cast<bool>(a); }
+
+template <typename T, typename... Args>
+local_shared_ptr<T> make_local_shared(Args&&... args) {
+    auto* block = new local_detail::InlineBlock<T>(std::forward<Args>(args)...);
+    return local_shared_ptr<T>(block->object(), block);
+}
+
+template <typename T>
+class local_weak_ptr {
+public:
+    local_weak_ptr() noexcept = default;
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    local_weak_ptr(const local_shared_ptr<U>& owner) noexcept : pointer(owner.pointer), block(owner.block) {
+        if (block) block->addWeak();
+    }
+
+    local_weak_ptr(const local_weak_ptr& other) noexcept : pointer(other.pointer), block(other.block) {
+        if (block) block->addWeak();
+    }
+    local_weak_ptr(local_weak_ptr&& other) noexcept
+        : pointer(std::exchange(other.pointer, nullptr)), block(std::exchange(other.block, nullptr)) {}
+
+    ~local_weak_ptr() {
+        if (block) block->releaseWeak();
+    }
+
+    local_weak_ptr& operator=(local_weak_ptr other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    void reset() noexcept { local_weak_ptr().swap(*this); }
+
+    void swap(local_weak_ptr& other) noexcept {
+        std::swap(pointer, other.pointer);
+        std::swap(block, other.block);
+    }
+
+    long use_count() const noexcept { return block ? block->use_count : 0; }
+    bool expired() const noexcept { return use_count() == 0; }
+
+    // An owning pointer to the object, or an empty one if it is gone
+    local_shared_ptr<T> lock() const noexcept {
+        if (expired()) return local_shared_ptr<T>();
+        block->addShared();
+        return local_shared_ptr<T>(pointer, block);
+    }
+
+private:
+    T* pointer = nullptr;
+    local_detail::ControlBlock* block = nullptr;
+};
+
+// A singly linked list whose nodes own their successor
+struct ListNode {
+    int value;
+    local_shared_ptr<ListNode> next;
+    ListNode(int value, local_shared_ptr<ListNode> next) : value(value), next(std::move(next)) {}
+};
+
+void localSharedExample() {
+    local_shared_ptr<MyClass> ptr1 = make_local_shared<MyClass>();
+    local_weak_ptr<MyClass> observer = ptr1;
+    {
+        local_shared_ptr<MyClass> ptr2 = ptr1;   // shared ownership, plain increment
+        ptr2->greet();
+        std::cout << "Use count: " << ptr1.use_count() << "\n"; // 2
+    }
+    std::cout << "Use count after ptr2 is gone: " << ptr1.use_count() << "\n"; // 1
+
+    ptr1.reset();                                 // object destroyed here
+    std::cout << "Observer expired: " << (observer.expired() ? "yes" : "no") << "\n";
+
+    // Self-referential reassignment: the old head is the only owner of head->next, so
+    // the assignment has to take its reference before the old head is destroyed
+    local_shared_ptr<ListNode> head = make_local_shared<ListNode>(1, make_local_shared<ListNode>(2, nullptr));
+    head = head->next;
+    std::cout << "Head after head = head->next: " << head->value
+              << ", use count " << head.use_count() << "\n"; // 2, 1
+}
+
 an use std::shared_ptr to manage a dynamic array, but it's a bit less straightforward than with unique_ptr or std::vector. Here's how you can do it properly:
 #include <iostream>
 #include <memory>